@@ -0,0 +1,247 @@
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#ifndef BENCH_BOARD
+#define BENCH_BOARD "unknown"
+#endif
+
+#define WIFI_SSID "ENTER_SSID"
+#define WIFI_PASS "ENTER_SSID_PWD"
+
+#define BENCH_PIN 2                 // D4, GPIO2 builtin LED
+#define GPIO_TOGGLES 100000         // toggles per GPIO measurement
+#define TIME_CALLS 10000            // millis()/micros() calls per measurement
+#define JITTER_TIME 10000           // ms of loop() iterations per jitter measurement
+#define WIFI_CONNECT_TIME 15000     // give up waiting for an AP after 15 seconds
+#define SERIAL_LINES 20             // lines in the sustained Serial print measurement
+
+// 48 characters + CRLF = 50 bytes on the wire
+#define SERIAL_LINE "# serial benchmark line 0123456789abcdefghijklmn"
+
+enum Phase
+{
+  PHASE_JITTER_WIFI_OFF,
+  PHASE_WIFI_CONNECT,
+  PHASE_JITTER_WIFI_ON,
+  PHASE_REPORT,
+  PHASE_DONE
+};
+
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint64_t sumSq;                   // integer, no soft float inside the timed loop
+} Stats;
+
+volatile uint32_t sink;             // keeps the timed calls from being optimized away
+
+float gpioDigitalWriteHz;
+float gpioRegisterHz;
+float millisCycles;
+float microsCycles;
+float serialFirstLineUs;
+float serialSustainedLineUs;
+Stats jitterWifiOff;
+Stats jitterWifiOn;
+bool wifiConnected = false;
+
+Phase phase = PHASE_JITTER_WIFI_OFF;
+uint32_t lastLoopMicros = 0;
+unsigned long phaseStart = 0;
+
+void benchGpio();
+void benchTimeCalls();
+void benchSerial();
+void statsReset(Stats *stats);
+void statsAdd(Stats *stats, uint32_t value);
+void printStats(const char *name, Stats *stats, bool last);
+void printReport();
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println();
+  Serial.println("# benchmark start");
+  pinMode(BENCH_PIN, OUTPUT);
+
+  WiFi.mode(WIFI_OFF);
+  WiFi.forceSleepBegin();
+  delay(10);
+
+  benchGpio();
+  benchTimeCalls();
+  benchSerial();
+
+  statsReset(&jitterWifiOff);
+  statsReset(&jitterWifiOn);
+  lastLoopMicros = micros();
+  phaseStart = millis();
+}
+
+void loop()
+{
+  uint32_t now = micros();
+  uint32_t delta = now - lastLoopMicros;
+  lastLoopMicros = now;
+
+  switch (phase)
+  {
+  case PHASE_JITTER_WIFI_OFF:
+    statsAdd(&jitterWifiOff, delta);
+    if (millis() - phaseStart >= JITTER_TIME)
+    {
+      WiFi.forceSleepWake();
+      WiFi.mode(WIFI_STA);
+      WiFi.begin(WIFI_SSID, WIFI_PASS);
+      phaseStart = millis();
+      phase = PHASE_WIFI_CONNECT;
+    }
+    break;
+
+  case PHASE_WIFI_CONNECT:
+    // measure anyway if the AP is unreachable, the radio is still scanning
+    wifiConnected = WiFi.status() == WL_CONNECTED;
+    if (wifiConnected || millis() - phaseStart > WIFI_CONNECT_TIME)
+    {
+      phase = PHASE_JITTER_WIFI_ON;
+      lastLoopMicros = micros();
+      phaseStart = millis();
+    }
+    break;
+
+  case PHASE_JITTER_WIFI_ON:
+    statsAdd(&jitterWifiOn, delta);
+    if (millis() - phaseStart >= JITTER_TIME)
+    {
+      phase = PHASE_REPORT;
+    }
+    break;
+
+  case PHASE_REPORT:
+    printReport();
+    phase = PHASE_DONE;
+    break;
+
+  case PHASE_DONE:
+    break;
+  }
+}
+
+void benchGpio()
+{
+  const uint32_t mask = 1 << BENCH_PIN;
+  uint32_t start = micros();
+  for (uint32_t i = 0; i < GPIO_TOGGLES / 2; i++)
+  {
+    digitalWrite(BENCH_PIN, HIGH);
+    digitalWrite(BENCH_PIN, LOW);
+  }
+  uint32_t elapsed = micros() - start;
+  gpioDigitalWriteHz = GPIO_TOGGLES * 1000000.0f / elapsed;
+
+  start = micros();
+  for (uint32_t i = 0; i < GPIO_TOGGLES / 2; i++)
+  {
+    GPOS = mask;
+    GPOC = mask;
+  }
+  elapsed = micros() - start;
+  gpioRegisterHz = GPIO_TOGGLES * 1000000.0f / elapsed;
+}
+
+void benchTimeCalls()
+{
+  uint32_t start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < TIME_CALLS; i++)
+  {
+    sink = i;
+  }
+  uint32_t baseline = ESP.getCycleCount() - start;
+
+  start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < TIME_CALLS; i++)
+  {
+    sink = millis();
+  }
+  millisCycles = (float)(ESP.getCycleCount() - start - baseline) / TIME_CALLS;
+
+  start = ESP.getCycleCount();
+  for (uint32_t i = 0; i < TIME_CALLS; i++)
+  {
+    sink = micros();
+  }
+  microsCycles = (float)(ESP.getCycleCount() - start - baseline) / TIME_CALLS;
+}
+
+void benchSerial()
+{
+  // a single line fits the UART FIFO, a burst has to wait for the wire
+  Serial.flush();
+  uint32_t start = micros();
+  Serial.println(SERIAL_LINE);
+  serialFirstLineUs = micros() - start;
+
+  Serial.flush();
+  start = micros();
+  for (uint8_t i = 0; i < SERIAL_LINES; i++)
+  {
+    Serial.println(SERIAL_LINE);
+  }
+  serialSustainedLineUs = (float)(micros() - start) / SERIAL_LINES;
+  Serial.flush();
+}
+
+void statsReset(Stats *stats)
+{
+  stats->count = 0;
+  stats->min = UINT32_MAX;
+  stats->max = 0;
+  stats->sum = 0;
+  stats->sumSq = 0;
+}
+
+void statsAdd(Stats *stats, uint32_t value)
+{
+  stats->count++;
+  stats->sum += value;
+  stats->sumSq += (uint64_t)value * value;
+  if (value < stats->min)
+  {
+    stats->min = value;
+  }
+  if (value > stats->max)
+  {
+    stats->max = value;
+  }
+}
+
+void printStats(const char *name, Stats *stats, bool last)
+{
+  double mean = (double)stats->sum / stats->count;
+  double variance = (double)stats->sumSq / stats->count - mean * mean;
+  Serial.printf("\"%s\":{\"samples\":%u,\"min_us\":%u,\"max_us\":%u,\"mean_us\":%.3f,\"stddev_us\":%.3f}%s",
+                name, stats->count, stats->min, stats->max, mean, sqrt(variance > 0 ? variance : 0),
+                last ? "" : ",");
+}
+
+/*
+  Whole report goes out as one JSON object on a single line prefixed
+  with "BENCH " so it can be grepped out of the monitor log.
+*/
+void printReport()
+{
+  uint8_t mhz = ESP.getCpuFreqMHz();
+  Serial.printf("BENCH {\"board\":\"%s\",\"chip_id\":\"%06x\",\"core\":\"%s\",\"sdk\":\"%s\",\"cpu_mhz\":%u,",
+                BENCH_BOARD, ESP.getChipId(), ESP.getCoreVersion().c_str(), ESP.getSdkVersion(), mhz);
+  Serial.printf("\"gpio_digitalwrite_hz\":%.0f,\"gpio_register_hz\":%.0f,", gpioDigitalWriteHz, gpioRegisterHz);
+  Serial.printf("\"millis_ns\":%.1f,\"micros_ns\":%.1f,", millisCycles * 1000 / mhz, microsCycles * 1000 / mhz);
+  Serial.printf("\"serial_line_bytes\":%u,\"serial_first_line_us\":%.1f,\"serial_sustained_line_us\":%.1f,",
+                (unsigned)(sizeof(SERIAL_LINE) - 1 + 2), serialFirstLineUs, serialSustainedLineUs);
+  Serial.printf("\"wifi_connected\":%s,", wifiConnected ? "true" : "false");
+  printStats("loop_wifi_off", &jitterWifiOff, false);
+  printStats("loop_wifi_on", &jitterWifiOn, true);
+  Serial.println("}");
+}
@@ -0,0 +1,50 @@
+/*
+ Logger - deferred logging, see Logger.h.
+*/
+
+#include "Logger.h"
+
+Logger logger;
+
+Logger::Logger(void)
+{
+  this->head = 0;
+  this->tail = 0;
+  this->droppedCount = 0;
+}
+
+/*
+  Entries are timestamped with the CPU cycle counter because it is a
+  single instruction. It wraps after ~53 s at 80 MHz, so the time printed
+  is millis() minus the entry's age, which is right as long as the buffer
+  is drained within that window.
+*/
+void Logger::update(void)
+{
+  if (this->head - this->tail > LOG_BUFFER_SIZE)
+  {
+    this->droppedCount += this->head - this->tail - LOG_BUFFER_SIZE;
+    this->tail = this->head - LOG_BUFFER_SIZE;
+  }
+
+  char line[LOG_LINE_SIZE];
+  uint32_t cyclesPerMs = ESP.getCpuFreqMHz() * 1000;
+  while (this->tail != this->head && Serial.availableForWrite() >= LOG_LINE_SIZE + 2)
+  {
+    entry_t *entry = &this->entries[this->tail & (LOG_BUFFER_SIZE - 1)];
+    unsigned long time = millis() - (ESP.getCycleCount() - entry->cycles) / cyclesPerMs;
+    int len = snprintf(line, sizeof(line), "%lu.%03lu %c ",
+                       time / 1000, time % 1000, "EWID"[entry->level - 1]);
+    snprintf(line + len, sizeof(line) - len, entry->format,
+             entry->args[0], entry->args[1], entry->args[2], entry->args[3]);
+    this->tail++;
+    Serial.println(line);
+  }
+
+  if (this->droppedCount && this->tail == this->head && Serial.availableForWrite() >= LOG_LINE_SIZE + 2)
+  {
+    snprintf(line, sizeof(line), "%u log entries dropped", this->droppedCount);
+    Serial.println(line);
+    this->droppedCount = 0;
+  }
+}
@@ -0,0 +1,131 @@
+/*
+ Logger - deferred logging for code that must not block on the UART.
+
+ A log call only stores the format string pointer (the format id) and up
+ to LOG_MAX_ARGS raw 32 bit arguments in a fixed RAM ring buffer. Text is
+ rendered later by update(), and only while the UART FIFO has room, so
+ neither side ever waits on Serial.
+
+ LOG_ERROR(...), LOG_WARN(...), LOG_INFO(...), LOG_DEBUG(...) take a
+ printf format and integer, char or string literal arguments. Calls above
+ LOG_LEVEL compile to nothing. Strings are stored as pointers, so only
+ pass strings that are still valid when the entry is drained (literals,
+ not szBuffer). Floats are not supported.
+*/
+
+#ifndef Logger_h
+#define Logger_h
+
+#include "Arduino.h"
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+/* Highest level compiled in, override with -D LOG_LEVEL=... */
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_BUFFER_SIZE
+/* Ring buffer entries, must be a power of 2. Oldest entries are overwritten */
+#define LOG_BUFFER_SIZE 32
+#endif
+
+#ifndef LOG_LINE_SIZE
+/* Longest rendered line, longer lines are cut */
+#define LOG_LINE_SIZE 80
+#endif
+
+#define LOG_MAX_ARGS 4
+
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "LOG_BUFFER_SIZE must be a power of 2");
+/* update() waits for this much room in the 128 byte UART TX FIFO */
+static_assert(LOG_LINE_SIZE + 2 <= 128, "LOG_LINE_SIZE + CRLF must fit the UART FIFO");
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logger.write(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logger.write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logger.write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logger.write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+class Logger
+{
+
+public:
+  Logger(void);
+
+  template <typename... Args>
+  inline void write(uint8_t level, const char *format, Args... args)
+  {
+    static_assert(sizeof...(args) <= LOG_MAX_ARGS, "too many log arguments");
+    entry_t *entry = &this->entries[this->head & (LOG_BUFFER_SIZE - 1)];
+    entry->cycles = ESP.getCycleCount();
+    entry->level = level;
+    entry->format = format;
+    uint32_t argv[] = {toArg(args)..., 0};
+    for (uint8_t i = 0; i < sizeof...(args); i++)
+    {
+      entry->args[i] = argv[i];
+    }
+    this->head++;
+  }
+
+  /*
+   Renders and prints buffered entries as long as they fit in the UART
+   FIFO without waiting, followed by a "N log entries dropped" line if
+   any were overwritten. Call when loop() is otherwise idle.
+  */
+  void update(void);
+
+private:
+  typedef struct entry_struct {
+    uint32_t cycles;
+    const char *format;
+    uint32_t args[LOG_MAX_ARGS];
+    uint8_t level;
+  } entry_t;
+
+  entry_t entries[LOG_BUFFER_SIZE];
+  uint32_t head;
+  uint32_t tail;
+  uint32_t droppedCount;
+
+  template <typename T>
+  static inline uint32_t toArg(T value)
+  {
+    static_assert(!std::is_floating_point<T>::value, "floats can not be logged");
+    return (uint32_t)value;
+  }
+
+  template <typename T>
+  static inline uint32_t toArg(T *value)
+  {
+    return (uint32_t)(uintptr_t)value;
+  }
+};
+
+extern Logger logger;
+
+#endif
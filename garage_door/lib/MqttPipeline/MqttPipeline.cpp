@@ -0,0 +1,198 @@
+/*
+ MqttPipeline - QoS 1 publishing with an in-flight ack window.
+ See MqttPipeline.h for the configuration defines.
+*/
+
+#include "MqttPipeline.h"
+
+MqttPipeline::MqttPipeline(Client *client, const char *server, uint16_t port, const char *user, const char *pass)
+    : Adafruit_MQTT_Client(client, server, port, user, pass)
+{
+  this->transport = client;
+  this->nextPacketId = 1;
+  this->online = false;
+  for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+  {
+    this->slots[i].packetId = 0; // 0 is never a valid MQTT packet id, marks a free slot
+  }
+}
+
+int8_t MqttPipeline::connect(void)
+{
+  int8_t ret = Adafruit_MQTT::connect();
+  if (ret == 0)
+  {
+    this->online = false;
+  }
+  return ret;
+}
+
+/*
+  Encodes the PUBLISH packet into a free slot so it can be resent as-is
+  (with the DUP flag set) until the broker acknowledges it.
+*/
+bool MqttPipeline::publishQos1(const char *topic, const char *payload)
+{
+  slot_t *slot = NULL;
+  for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+  {
+    if (this->slots[i].packetId == 0)
+    {
+      slot = &this->slots[i];
+      break;
+    }
+  }
+  if (slot == NULL)
+  {
+    return false;
+  }
+
+  uint16_t topicLen = strlen(topic);
+  uint16_t payloadLen = strlen(payload);
+  uint16_t remaining = 2 + topicLen + 2 + payloadLen;
+  // 1 byte fixed header + up to 2 bytes remaining length
+  if (remaining + 3 > MQTT_PIPELINE_PACKET_SIZE)
+  {
+    return false;
+  }
+
+  uint16_t packetId = this->allocPacketId();
+  uint8_t *p = slot->packet;
+  *p++ = (MQTT_CTRL_PUBLISH << 4) | (MQTT_QOS_1 << 1);
+  do
+  {
+    uint8_t encoded = remaining % 128;
+    remaining /= 128;
+    if (remaining > 0)
+    {
+      encoded |= 0x80;
+    }
+    *p++ = encoded;
+  } while (remaining > 0);
+  *p++ = topicLen >> 8;
+  *p++ = topicLen & 0xFF;
+  memcpy(p, topic, topicLen);
+  p += topicLen;
+  *p++ = packetId >> 8;
+  *p++ = packetId & 0xFF;
+  memcpy(p, payload, payloadLen);
+  p += payloadLen;
+
+  slot->len = p - slot->packet;
+  slot->packetId = packetId;
+  slot->sent = false;
+  slot->sentTime = millis();
+  if (this->online && this->connected())
+  {
+    this->transmit(slot);
+  }
+  return true;
+}
+
+void MqttPipeline::update(void)
+{
+  if (!this->connected())
+  {
+    this->online = false;
+    return;
+  }
+
+  if (!this->online)
+  {
+    this->online = true;
+    for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+    {
+      if (this->slots[i].packetId != 0)
+      {
+        this->transmit(&this->slots[i]);
+      }
+    }
+  }
+
+  while (this->transport->available())
+  {
+    uint16_t len = this->readFullPacket(this->buffer, MAXBUFFERSIZE, MQTT_PIPELINE_READ_TIMEOUT);
+    if (len == 0)
+    {
+      break;
+    }
+    if ((this->buffer[0] >> 4) == MQTT_CTRL_PUBACK && len >= 4)
+    {
+      this->acknowledge((this->buffer[2] << 8) | this->buffer[3]);
+    }
+  }
+
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+  {
+    slot_t *slot = &this->slots[i];
+    if (slot->packetId != 0 && now - slot->sentTime >= MQTT_PIPELINE_RETRY_TIME)
+    {
+      this->transmit(slot);
+    }
+  }
+}
+
+uint8_t MqttPipeline::inFlight(void)
+{
+  uint8_t count = 0;
+  for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+  {
+    if (this->slots[i].packetId != 0)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+
+/*
+  Next packet id, skipping 0 and any id still waiting for its PUBACK.
+*/
+uint16_t MqttPipeline::allocPacketId(void)
+{
+  for (;;)
+  {
+    if (this->nextPacketId == 0)
+    {
+      this->nextPacketId = 1;
+    }
+    bool used = false;
+    for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+    {
+      if (this->slots[i].packetId == this->nextPacketId)
+      {
+        used = true;
+        break;
+      }
+    }
+    if (!used)
+    {
+      return this->nextPacketId++;
+    }
+    this->nextPacketId++;
+  }
+}
+
+void MqttPipeline::transmit(slot_t *slot)
+{
+  if (slot->sent)
+  {
+    slot->packet[0] |= 0x08; // DUP flag on every retransmission
+  }
+  this->sendPacket(slot->packet, slot->len);
+  slot->sent = true;
+  slot->sentTime = millis();
+}
+
+void MqttPipeline::acknowledge(uint16_t packetId)
+{
+  for (uint8_t i = 0; i < MQTT_PIPELINE_WINDOW; i++)
+  {
+    if (this->slots[i].packetId == packetId)
+    {
+      this->slots[i].packetId = 0;
+      return;
+    }
+  }
+}
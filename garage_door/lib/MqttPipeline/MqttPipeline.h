@@ -0,0 +1,86 @@
+/*
+ MqttPipeline - QoS 1 publishing on top of Adafruit_MQTT_Client that
+ keeps a small window of unacknowledged messages in flight instead of
+ blocking on every PUBACK.
+
+ update() consumes every incoming packet and drops anything that is not
+ a PUBACK, so ping() and readSubscription() of the base class can not be
+ used with it. Publish-only clients keep the connection alive through
+ their own traffic.
+*/
+
+#ifndef MqttPipeline_h
+#define MqttPipeline_h
+
+#include "Arduino.h"
+#include <Client.h>
+#include "Adafruit_MQTT.h"
+#include <Adafruit_MQTT_Client.h>
+
+#ifndef MQTT_PIPELINE_WINDOW
+/* How many QoS 1 publishes may be waiting for a PUBACK at the same time */
+#define MQTT_PIPELINE_WINDOW 4
+#endif
+
+#ifndef MQTT_PIPELINE_PACKET_SIZE
+/* Largest encoded PUBLISH packet (header + topic + id + payload) kept per slot */
+#define MQTT_PIPELINE_PACKET_SIZE 96
+#endif
+
+#ifndef MQTT_PIPELINE_RETRY_TIME
+/* Resend an unacknowledged publish after this many ms */
+#define MQTT_PIPELINE_RETRY_TIME 5000
+#endif
+
+#ifndef MQTT_PIPELINE_READ_TIMEOUT
+/* Max ms spent reading the rest of a packet once its first byte arrived */
+#define MQTT_PIPELINE_READ_TIMEOUT 20
+#endif
+
+class MqttPipeline : public Adafruit_MQTT_Client
+{
+
+public:
+  MqttPipeline(Client *client, const char *server, uint16_t port, const char *user = "", const char *pass = "");
+
+  /*
+   Same as Adafruit_MQTT::connect(), but on success the whole window is
+   resent by the next update().
+  */
+  int8_t connect(void);
+
+  /*
+   Queues a QoS 1 publish and sends it right away when connected. Does not
+   wait for the PUBACK. Returns false when the window is full or the
+   packet does not fit in a slot.
+  */
+  bool publishQos1(const char *topic, const char *payload);
+
+  /*
+   Matches incoming PUBACKs, retransmits timed out publishes and resends
+   the whole window after a reconnect. Must be called from loop().
+  */
+  void update(void);
+
+  uint8_t inFlight(void);
+
+private:
+  typedef struct slot_struct {
+    uint16_t packetId;
+    uint16_t len;
+    unsigned long sentTime;
+    bool sent;
+    uint8_t packet[MQTT_PIPELINE_PACKET_SIZE];
+  } slot_t;
+
+  Client *transport;
+  slot_t slots[MQTT_PIPELINE_WINDOW];
+  uint16_t nextPacketId;
+  bool online;
+
+  uint16_t allocPacketId(void);
+  void transmit(slot_t *slot);
+  void acknowledge(uint16_t packetId);
+};
+
+#endif
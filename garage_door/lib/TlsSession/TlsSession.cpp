@@ -0,0 +1,67 @@
+/*
+ TlsSession - BearSSL session cache in RTC user memory.
+ See TlsSession.h for the configuration defines.
+*/
+
+#include "TlsSession.h"
+
+TlsSession::TlsSession(void)
+{
+}
+
+BearSSL::Session *TlsSession::get(void)
+{
+  return &this->session;
+}
+
+/*
+  BearSSL::Session only wraps a plain br_ssl_session_parameters struct
+  (session id, cipher suite, master secret) and does not expose it, so
+  the object is copied byte for byte.
+*/
+bool TlsSession::restore(void)
+{
+  rtc_t rtc;
+  if (!ESP.rtcUserMemoryRead(TLS_SESSION_RTC_OFFSET, (uint32_t *)&rtc, sizeof(rtc)))
+  {
+    return false;
+  }
+  if (rtc.magic != TLS_SESSION_MAGIC || rtc.crc != crc32(rtc.data, sizeof(BearSSL::Session)))
+  {
+    return false;
+  }
+  memcpy((void *)&this->session, rtc.data, sizeof(BearSSL::Session));
+  return true;
+}
+
+bool TlsSession::store(void)
+{
+  rtc_t rtc;
+  memset(&rtc, 0, sizeof(rtc));
+  memcpy(rtc.data, (const void *)&this->session, sizeof(BearSSL::Session));
+  rtc.magic = TLS_SESSION_MAGIC;
+  rtc.crc = crc32(rtc.data, sizeof(BearSSL::Session));
+  return ESP.rtcUserMemoryWrite(TLS_SESSION_RTC_OFFSET, (uint32_t *)&rtc, sizeof(rtc));
+}
+
+void TlsSession::clear(void)
+{
+  rtc_t rtc;
+  memset(&rtc, 0, sizeof(rtc));
+  ESP.rtcUserMemoryWrite(TLS_SESSION_RTC_OFFSET, (uint32_t *)&rtc, sizeof(rtc));
+  this->session = BearSSL::Session();
+}
+
+uint32_t TlsSession::crc32(const uint8_t *data, size_t len)
+{
+  uint32_t crc = 0xffffffff;
+  while (len--)
+  {
+    crc ^= *data++;
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ (0xedb88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
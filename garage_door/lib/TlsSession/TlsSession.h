@@ -0,0 +1,55 @@
+/*
+ TlsSession - keeps the BearSSL session parameters of the MQTT TLS
+ connection in RTC user memory, so a reconnect (or a WDT/soft reset)
+ can resume the previous session instead of a full handshake.
+*/
+
+#ifndef TlsSession_h
+#define TlsSession_h
+
+#include "Arduino.h"
+#include <WiFiClientSecureBearSSL.h>
+
+#ifndef TLS_SESSION_RTC_OFFSET
+/* RTC user memory offset in 4 byte blocks, blocks 0..31 hold the eboot (OTA) command */
+#define TLS_SESSION_RTC_OFFSET 32
+#endif
+
+#define TLS_SESSION_MAGIC 0x544c5331 // "TLS1"
+
+class TlsSession
+{
+
+public:
+  TlsSession(void);
+
+  /* Session to pass to WiFiClientSecure::setSession() */
+  BearSSL::Session *get(void);
+
+  /*
+   Loads the session saved by store(). Returns false (and leaves an empty
+   session, i.e. full handshake) when RTC memory holds nothing valid,
+   which is the case after power on.
+  */
+  bool restore(void);
+
+  /* Saves the current session, call after a successful connect */
+  bool store(void);
+
+  void clear(void);
+
+private:
+  typedef struct rtc_struct {
+    uint32_t magic;
+    uint32_t crc;
+    uint8_t data[(sizeof(BearSSL::Session) + 3) & ~3];
+  } rtc_t;
+
+  static_assert(TLS_SESSION_RTC_OFFSET * 4 + sizeof(rtc_t) <= 512, "TLS session does not fit in RTC user memory");
+
+  BearSSL::Session session;
+
+  static uint32_t crc32(const uint8_t *data, size_t len);
+};
+
+#endif
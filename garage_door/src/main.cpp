@@ -5,6 +5,9 @@
 #include <Adafruit_MQTT_Client.h>
 #include <Debounce.h> // https://github.com/arnebech/Debounce (copied in lib folder)
 #include <Timer.h>    // https://github.com/JChristensen/Timer/tree/v2.1 (copied in lib folder)
+#include <MqttPipeline.h>
+#include <TlsSession.h>
+#include <Logger.h>
 
 #define WIFI_SSID "ENTER_SSID"
 #define WIFI_PASS "ENTER_SSID_PWD"
@@ -12,7 +15,15 @@
 #define MQTT_SERVER "ENTER_MQTT_IP"
 #define MQTT_USERNAME "ENTER_MQTT_USR"
 #define MQTT_PASSWORD "ENTER_MQTT_PWD"
+#define MQTT_TLS 0              // 0 = plain TCP, 1 = TLS with session resumption (see lib/TlsSession)
+#if MQTT_TLS
+#define MQTT_PORT 8883
+#define MQTT_TLS_FINGERPRINT "ENTER_MQTT_SHA1_FINGERPRINT"
+#define MQTT_TLS_BUFFER 1024    // TLS rx/tx buffer, only used if the broker supports max fragment length
+#else
 #define MQTT_PORT 1883
+#endif
+#define MQTT_QOS 1              // 0 = fire and forget, 1 = acknowledged, pipelined (see lib/MqttPipeline)
 
 #define GRGE_1_PIN 13           // D7, GPIO13 Garage Door - 1 input pin
 #define GRGE_2_PIN 12           // D6, GPIO12 Garage Door - 2 input pin
@@ -39,12 +50,17 @@ int doorOpenTotalTime[3] = {0};
 
 Debounce debounce = Debounce();
 Timer timer;
+#if MQTT_TLS
+BearSSL::WiFiClientSecure client;
+TlsSession tlsSession;
+#else
 WiFiClient client;
-Adafruit_MQTT_Client mqttClient(&client, MQTT_SERVER, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD);
+#endif
+MqttPipeline mqttClient(&client, MQTT_SERVER, MQTT_PORT, MQTT_USERNAME, MQTT_PASSWORD);
 Adafruit_NeoPixel strip = Adafruit_NeoPixel(NUMPIXELS, PIN, NEO_GRB + NEO_KHZ800);
 
 void pingMQTTMessage(void *context);
-void sendMessage(String topic, String message);
+void sendMessage(const char *topic, const char *message);
 void callbackGarage(bool state, uint8_t pin);
 void callbackDoorOpen(void *context);
 void mqttConnect();
@@ -72,7 +88,17 @@ void setup()
   Serial.println();
   Serial.println("Connected, IP address: ");
   Serial.println(WiFi.localIP());
-  
+
+#if MQTT_TLS
+  client.setFingerprint(MQTT_TLS_FINGERPRINT);
+  if (BearSSL::WiFiClientSecure::probeMaxFragmentLength(MQTT_SERVER, MQTT_PORT, MQTT_TLS_BUFFER))
+  {
+    client.setBufferSizes(MQTT_TLS_BUFFER, MQTT_TLS_BUFFER);
+  }
+  tlsSession.restore(); // resume the session from before a WDT reset
+  client.setSession(tlsSession.get());
+#endif
+
   timer.every(MQTT_PING_TIME, pingMQTTMessage, (void *)0);
 
   strip.begin();
@@ -95,21 +121,32 @@ void setup()
 void loop()
 {
   mqttConnect();
+  mqttClient.update();
   debounce.update();
   timer.update();
   strip.show();
+  logger.update();
 }
 
 void pingMQTTMessage(void *context)
 {
   sprintf(szBuffer, "SENSOR/%s/STATUS", deviceName.c_str());
-  sendMessage(szBuffer, "ACTIVE");
+  LOG_DEBUG("ping");
+  // QoS 0 on purpose, heartbeats must not take window slots from door events
+  mqttClient.publish(szBuffer, "ACTIVE");
 }
 
-void sendMessage(String topic, String message)
+void sendMessage(const char *topic, const char *message)
 {
-  Serial.println(topic + " " + message);
-  mqttClient.publish((char *)topic.c_str(), (char *)message.c_str());
+#if MQTT_QOS == 1
+  if (!mqttClient.publishQos1(topic, message))
+  {
+    // window full or message larger than MQTT_PIPELINE_PACKET_SIZE
+    LOG_WARN("MQTT publish not queued, %u in flight", mqttClient.inFlight());
+  }
+#else
+  mqttClient.publish((char *)topic, (char *)message);
+#endif
 }
 
 void callbackGarage(bool state, uint8_t pin)
@@ -143,6 +180,7 @@ void callbackGarage(bool state, uint8_t pin)
     timer.stop(doorOpenTimerArray[ledNum]);
   }
   strip.show();
+  LOG_INFO("Garage Door %u => %s", doorNum, (state ? "Open" : "Close"));
   sprintf(szBuffer, "SENSOR/%s/DOOR/%u", deviceName.c_str(), doorNum);
   sprintf(szState, "Garage Door %u => %s", doorNum, (state ? "Open" : "Close"));
   sendMessage(szBuffer, szState);
@@ -169,6 +207,7 @@ void callbackDoorOpen(void *context)
     ledNum = GRGE_LED_3;
   }
   doorOpenTotalTime[ledNum] = doorOpenTotalTime[ledNum] + (GDOOR_OPEN_TIME / 60000);
+  LOG_INFO("Garage Door %u => Open for %u minutes", doorNum, doorOpenTotalTime[ledNum]);
   sprintf(szBuffer, "SENSOR/%s/DOOR/%u", deviceName.c_str(), doorNum);
   sprintf(szState, "Garage Door %u => Open for %u minutes", doorNum, doorOpenTotalTime[ledNum]);
   sendMessage(szBuffer, szState);
@@ -196,4 +235,7 @@ void mqttConnect()
     }
   }
   Serial.println("MQTT Connected!");
+#if MQTT_TLS
+  tlsSession.store();
+#endif
 }
@@ -0,0 +1,155 @@
+/*
+  Full vs resumed TLS handshake time and heap use against a local broker.
+
+  A local mosquitto listener is enough, e.g. in mosquitto.conf:
+    listener 8883
+    certfile /etc/mosquitto/certs/server.crt
+    keyfile /etc/mosquitto/certs/server.key
+  and the SHA1 fingerprint of server.crt in MQTT_TLS_FINGERPRINT:
+    openssl x509 -in server.crt -noout -fingerprint -sha1
+
+  Report is a single "BENCH {...}" JSON line, like the blink_led benchmark.
+  "resumed" counts the resumed runs where the broker really accepted the
+  cached session; if it is 0 the broker has no session cache.
+*/
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+#include <TlsSession.h>
+
+#define WIFI_SSID "ENTER_SSID"
+#define WIFI_PASS "ENTER_SSID_PWD"
+
+#define MQTT_SERVER "ENTER_MQTT_IP"
+#define MQTT_PORT 8883
+#define MQTT_TLS_FINGERPRINT "ENTER_MQTT_SHA1_FINGERPRINT"
+
+#define HANDSHAKES 5                // runs per mode
+#define TLS_BUFFERS 3               // default, 1024 and 512 byte buffers
+
+typedef struct
+{
+  uint16_t rx;
+  uint16_t tx;
+} Buffers;
+
+typedef struct
+{
+  uint8_t ok;
+  uint8_t resumed;
+  uint32_t minMs;
+  uint32_t maxMs;
+  uint32_t sumMs;
+  uint32_t heapUsed;                // worst heap in use while connected
+} Result;
+
+// 0 = leave the BearSSL defaults (16k rx / 512 tx)
+const Buffers buffers[TLS_BUFFERS] = {{0, 0}, {1024, 1024}, {512, 512}};
+
+bool handshake(BearSSL::Session *session, const Buffers *buf, Result *result);
+void printResult(const char *name, const Result *result, bool last);
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.println();
+  Serial.println("# tls benchmark start");
+
+  WiFi.mode(WIFI_STA);
+  WiFi.begin(WIFI_SSID, WIFI_PASS);
+  while (WiFi.status() != WL_CONNECTED)
+  {
+    delay(500);
+  }
+
+  Serial.printf("BENCH {\"core\":\"%s\",\"cpu_mhz\":%u,\"server\":\"%s\",\"port\":%u,\"runs\":[",
+                ESP.getCoreVersion().c_str(), ESP.getCpuFreqMHz(), MQTT_SERVER, MQTT_PORT);
+  for (uint8_t b = 0; b < TLS_BUFFERS; b++)
+  {
+    const Buffers *buf = &buffers[b];
+    bool mfln = buf->rx == 0 ||
+                BearSSL::WiFiClientSecure::probeMaxFragmentLength(MQTT_SERVER, MQTT_PORT, buf->rx);
+    Result full = {0, 0, UINT32_MAX, 0, 0, 0};
+    Result resumed = {0, 0, UINT32_MAX, 0, 0, 0};
+
+    if (mfln)
+    {
+      for (uint8_t i = 0; i < HANDSHAKES; i++)
+      {
+        BearSSL::Session fresh;
+        handshake(&fresh, buf, &full);
+      }
+
+      // prime the cache, then go through RTC memory the way a reset would
+      TlsSession cache;
+      cache.clear();
+      Result prime = {0, 0, UINT32_MAX, 0, 0, 0};
+      handshake(cache.get(), buf, &prime);
+      cache.store();
+      for (uint8_t i = 0; i < HANDSHAKES; i++)
+      {
+        TlsSession restored;
+        restored.restore();
+        handshake(restored.get(), buf, &resumed);
+      }
+    }
+
+    Serial.printf("%s{\"rx_buf\":%u,\"tx_buf\":%u,\"mfln\":%s,", b ? "," : "",
+                  buf->rx, buf->tx, mfln ? "true" : "false");
+    printResult("full", &full, false);
+    printResult("resumed", &resumed, true);
+    Serial.print("}");
+  }
+  Serial.println("]}");
+}
+
+void loop()
+{
+}
+
+/*
+  One TLS connect/stop. A session that comes back byte for byte identical
+  was resumed, a new handshake always gets a new session id.
+*/
+bool handshake(BearSSL::Session *session, const Buffers *buf, Result *result)
+{
+  BearSSL::WiFiClientSecure client;
+  client.setFingerprint(MQTT_TLS_FINGERPRINT);
+  if (buf->rx)
+  {
+    client.setBufferSizes(buf->rx, buf->tx);
+  }
+  client.setSession(session);
+
+  BearSSL::Session before = *session;
+  uint32_t heapBefore = ESP.getFreeHeap();
+  unsigned long start = millis();
+  bool ok = client.connect(MQTT_SERVER, MQTT_PORT);
+  uint32_t elapsed = millis() - start;
+  uint32_t heapUsed = heapBefore - ESP.getFreeHeap();
+  client.stop();
+
+  if (!ok)
+  {
+    return false;
+  }
+  result->ok++;
+  if (memcmp((const void *)&before, (const void *)session, sizeof(BearSSL::Session)) == 0)
+  {
+    result->resumed++;
+  }
+  result->sumMs += elapsed;
+  result->minMs = min(result->minMs, elapsed);
+  result->maxMs = max(result->maxMs, elapsed);
+  result->heapUsed = max(result->heapUsed, heapUsed);
+  return true;
+}
+
+void printResult(const char *name, const Result *result, bool last)
+{
+  Serial.printf("\"%s\":{\"ok\":%u,\"resumed\":%u,\"min_ms\":%u,\"max_ms\":%u,\"mean_ms\":%u,\"heap_used\":%u}%s",
+                name, result->ok, result->resumed,
+                result->ok ? result->minMs : 0, result->maxMs,
+                result->ok ? result->sumMs / result->ok : 0, result->heapUsed,
+                last ? "" : ",");
+}